@@ -39,6 +39,8 @@ public class PixelizationMaterials : ModuleRules
                 "Core",
                 "CoreUObject",
 				"Engine",
+				"RHI",
+				"RenderCore",
 				"Slate",
 				"SlateCore",
                 "DesktopPlatform",
@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AdaptivePaletteComponent.h"
+#include "PaletteSearch.h"
+
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+#include "TextureResource.h"
+
+#include <atomic>
+
+//Shared with render commands so it outlives the component if one is still queued
+struct FAdaptivePaletteReadback {
+    FAdaptivePaletteReadback()
+        : GPUReadback(TEXT("AdaptivePaletteReadback")) {
+    }
+
+    FRHIGPUTextureReadback GPUReadback;
+
+    //Written on the render thread, read on the game thread once bPixelsReady is set
+    EPixelFormat Format = PF_Unknown;
+    int32 Width = 0;
+    int32 Height = 0;
+    TArray<FLinearColor> Pixels;
+    double ConvertSeconds = 0.;
+    std::atomic<bool> bCopyFailed = false;
+    std::atomic<bool> bPixelsReady = false;
+    bool bWarnedFormat = false;
+
+    void Resolve() {
+        double start = FPlatformTime::Seconds();
+        Pixels.Reset();
+
+        //Float targets hold linear scene color, 8 bit targets (RTF_RGBA8, FinalColorLDR) hold sRGB encoded bytes and are decoded
+        bool bSupported = Format == PF_FloatRGBA || Format == PF_A32B32G32R32F || Format == PF_B8G8R8A8;
+        int32 rowPitch = 0;
+        const void* data = bSupported ? GPUReadback.Lock(rowPitch) : nullptr;
+        if (data) {
+            Pixels.SetNumUninitialized(Width * Height);
+            for (int32 y = 0; y < Height; y++) {
+                for (int32 x = 0; x < Width; x++) {
+                    const int32 texel = y * rowPitch + x;
+                    FLinearColor& pixel = Pixels[y * Width + x];
+                    if (Format == PF_FloatRGBA) pixel = FLinearColor(static_cast<const FFloat16Color*>(data)[texel]);
+                    else if (Format == PF_A32B32G32R32F) pixel = static_cast<const FLinearColor*>(data)[texel];
+                    else pixel = FLinearColor(static_cast<const FColor*>(data)[texel]);
+                }
+            }
+            GPUReadback.Unlock();
+        }
+
+        ConvertSeconds = FPlatformTime::Seconds() - start;
+        bPixelsReady = true;
+    }
+};
+
+UAdaptivePaletteComponent::UAdaptivePaletteComponent() {
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void UAdaptivePaletteComponent::BeginPlay() {
+    Super::BeginPlay();
+    ApplySettings();
+
+    Readback = MakeShared<FAdaptivePaletteReadback, ESPMode::ThreadSafe>();
+    ReadbackState = EReadbackState::Idle;
+
+    LUTTexture = UTexture2D::CreateTransient(DitherLUTWidth, DitherLUTHeight, PF_FloatRGBA, TEXT("AdaptivePaletteLUT"));
+    LUTTexture->Filter = TF_Nearest;
+    LUTTexture->SRGB = false;
+    LUTTexture->AddressX = TA_Clamp;
+    LUTTexture->AddressY = TA_Clamp;
+    LUTTexture->UpdateResource();
+}
+
+void UAdaptivePaletteComponent::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+    Quantizer.Wait();
+    Readback.Reset();
+    Super::EndPlay(EndPlayReason);
+}
+
+void UAdaptivePaletteComponent::ApplySettings() {
+    Quantizer.SetSettings(Settings);
+}
+
+void UAdaptivePaletteComponent::ResetPalette() {
+    Quantizer.Reset();
+}
+
+void UAdaptivePaletteComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (Quantizer.FetchResult()) {
+        ApplyToMaterials();
+        OnPaletteUpdated.Broadcast(Quantizer.GetPalette());
+    }
+
+    UpdateReadback();
+}
+
+void UAdaptivePaletteComponent::UpdateReadback() {
+    if (!Readback) return;
+
+    switch (ReadbackState) {
+    case EReadbackState::Idle: {
+        if (!SourceTarget || Quantizer.IsBusy()) return;
+        FTextureRenderTargetResource* resource = SourceTarget->GameThread_GetRenderTargetResource();
+        if (!resource) return;
+
+        ENQUEUE_RENDER_COMMAND(AdaptivePaletteCopy)([readback = Readback, resource](FRHICommandListImmediate& RHICmdList) {
+            FRHITexture* texture = resource->GetRenderTargetTexture();
+            if (!texture) {
+                readback->bCopyFailed = true;
+                return;
+            }
+            readback->Format = texture->GetFormat();
+            readback->Width = texture->GetSizeX();
+            readback->Height = texture->GetSizeY();
+            readback->GPUReadback.EnqueueCopy(RHICmdList, texture);
+        });
+        ReadbackState = EReadbackState::Copying;
+        break;
+    }
+    case EReadbackState::Copying:
+        if (Readback->bCopyFailed) {
+            Readback->bCopyFailed = false;
+            ReadbackState = EReadbackState::Idle;
+            return;
+        }
+        if (!Readback->GPUReadback.IsReady()) return;
+        Readback->bPixelsReady = false;
+        ENQUEUE_RENDER_COMMAND(AdaptivePaletteResolve)([readback = Readback](FRHICommandListImmediate& RHICmdList) {
+            readback->Resolve();
+        });
+        ReadbackState = EReadbackState::Mapping;
+        break;
+    case EReadbackState::Mapping:
+        if (!Readback->bPixelsReady) return;
+        if (Readback->Pixels.IsEmpty()) {
+            if (!Readback->bWarnedFormat) UE_LOG(LogTemp, Warning, TEXT("Adaptive palette: unsupported source target format %d"), (int32)Readback->Format);
+            Readback->bWarnedFormat = true;
+        } else {
+            Quantizer.SubmitFrame(Readback->Pixels, Readback->Width, Readback->Height, Readback->ConvertSeconds);
+        }
+        ReadbackState = EReadbackState::Idle;
+        break;
+    }
+}
+
+void UAdaptivePaletteComponent::ApplyToMaterials() {
+    const TArray<FFloat16Color>& lut = Quantizer.GetDitherLUT();
+    if (!LUTTexture || lut.Num() != DitherLUTWidth * DitherLUTHeight || Quantizer.GetDitherLUTVersion() == UploadedLUTVersion) return;
+    UploadedLUTVersion = Quantizer.GetDitherLUTVersion();
+
+    //UpdateTextureRegions uploads on the render thread, the copy is freed by the cleanup callback
+    const uint32 pitch = DitherLUTWidth * sizeof(FFloat16Color);
+    uint8* data = new uint8[lut.Num() * sizeof(FFloat16Color)];
+    FMemory::Memcpy(data, lut.GetData(), lut.Num() * sizeof(FFloat16Color));
+    FUpdateTextureRegion2D* region = new FUpdateTextureRegion2D(0, 0, 0, 0, DitherLUTWidth, DitherLUTHeight);
+
+    LUTTexture->UpdateTextureRegions(0, 1, region, pitch, sizeof(FFloat16Color), data, [](uint8* SrcData, const FUpdateTextureRegion2D* Regions) {
+        delete[] SrcData;
+        delete Regions;
+    });
+
+    for (UMaterialInstanceDynamic* material : TargetMaterials) {
+        if (material) material->SetTextureParameterValue(LUTParameterName, LUTTexture);
+    }
+}
@@ -0,0 +1,318 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AdaptivePaletteQuantizer.h"
+#include "PaletteSearch.h"
+#include "Tasks/Task.h"
+
+namespace {
+    //5 bits per channel
+    const int32 HistogramBits = 5;
+    const int32 HistogramSide = 1 << HistogramBits;
+    const int32 HistogramSize = HistogramSide * HistogramSide * HistogramSide;
+
+    const float ConvergenceEpsilon = 1e-4f;
+
+    //One FindClosestBatch query block, the smallest step of a LUT rebuild
+    const int32 LUTChunkCells = 16;
+
+    int32 HistogramKey(const FLinearColor& color) {
+        int32 R = FMath::Clamp(FMath::FloorToInt32(color.R * HistogramSide), 0, HistogramSide - 1);
+        int32 G = FMath::Clamp(FMath::FloorToInt32(color.G * HistogramSide), 0, HistogramSide - 1);
+        int32 B = FMath::Clamp(FMath::FloorToInt32(color.B * HistogramSide), 0, HistogramSide - 1);
+        return (R << (HistogramBits * 2)) | (G << HistogramBits) | B;
+    }
+
+    FVector3f ToVector(const FLinearColor& color) {
+        return FVector3f(color.R, color.G, color.B);
+    }
+
+    //UI metadata does not protect values set from Blueprint or C++
+    FAdaptivePaletteSettings Sanitize(FAdaptivePaletteSettings Settings) {
+        Settings.PaletteSize = FMath::Clamp(Settings.PaletteSize, 2, 256);
+        Settings.SampleSize.X = FMath::Max(Settings.SampleSize.X, 1);
+        Settings.SampleSize.Y = FMath::Max(Settings.SampleSize.Y, 1);
+        Settings.MaxIterations = FMath::Max(Settings.MaxIterations, 1);
+        Settings.TimeBudgetSeconds = FMath::Max(Settings.TimeBudgetSeconds, 0.f);
+        Settings.MaxShiftPerFrame = FMath::Max(Settings.MaxShiftPerFrame, 0.f);
+        return Settings;
+    }
+}
+
+FAdaptivePaletteQuantizer::FAdaptivePaletteQuantizer(const FAdaptivePaletteSettings& InSettings)
+    : Settings(Sanitize(InSettings)) {
+    BinLookup.Init(INDEX_NONE, HistogramSize);
+}
+
+FAdaptivePaletteQuantizer::~FAdaptivePaletteQuantizer() {
+    Wait();
+}
+
+void FAdaptivePaletteQuantizer::SetSettings(const FAdaptivePaletteSettings& InSettings) {
+    Wait();
+    Settings = Sanitize(InSettings);
+    LUTCursor = INDEX_NONE;
+}
+
+void FAdaptivePaletteQuantizer::Wait() {
+    if (PendingTask.IsValid()) PendingTask.Wait();
+}
+
+void FAdaptivePaletteQuantizer::Reset() {
+    Wait();
+    PendingTask = UE::Tasks::FTask();
+    Palette.Empty();
+    SearchPalette.Empty();
+    DitherLUT.Empty();
+    WorkPalette.Empty();
+    WorkSearchPalette.Empty();
+    WorkDitherLUT.Empty();
+    LUTPalette.Empty();
+    LUTContext = FPaletteSearchContext();
+    LUTCursor = INDEX_NONE;
+    bWorkLUTReady = false;
+    Stats = FAdaptivePaletteStats();
+    WorkStats = FAdaptivePaletteStats();
+}
+
+void FAdaptivePaletteQuantizer::ProcessFrame(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height) {
+    Wait();
+    FetchResult();
+
+    double start = FPlatformTime::Seconds();
+    Downsample(Pixels, Width, Height, PendingSamples);
+    Quantize(PendingSamples, FPlatformTime::Seconds() - start);
+    Publish();
+}
+
+bool FAdaptivePaletteQuantizer::SubmitFrame(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height, double ReadbackSeconds) {
+    if (IsBusy()) return false;
+    FetchResult();
+
+    double start = FPlatformTime::Seconds();
+    Downsample(Pixels, Width, Height, PendingSamples);
+    double preparationSeconds = ReadbackSeconds + (FPlatformTime::Seconds() - start);
+
+    PendingTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, preparationSeconds]() {
+        Quantize(PendingSamples, preparationSeconds);
+    });
+    return true;
+}
+
+bool FAdaptivePaletteQuantizer::FetchResult() {
+    if (!PendingTask.IsValid() || !PendingTask.IsCompleted()) return false;
+    PendingTask = UE::Tasks::FTask();
+    Publish();
+    return true;
+}
+
+void FAdaptivePaletteQuantizer::Publish() {
+    Palette = WorkPalette;
+    SearchPalette = WorkSearchPalette;
+    Stats = WorkStats;
+    if (bWorkLUTReady) {
+        DitherLUT = WorkDitherLUT;
+        DitherLUTVersion++;
+        bWorkLUTReady = false;
+    }
+}
+
+//----
+
+void FAdaptivePaletteQuantizer::Downsample(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height, TArray<FLinearColor>& OutSamples) const {
+    OutSamples.Reset();
+    if (Width <= 0 || Height <= 0 || Pixels.Num() < Width * Height) return;
+
+    int32 SW = FMath::Clamp(Settings.SampleSize.X, 1, Width);
+    int32 SH = FMath::Clamp(Settings.SampleSize.Y, 1, Height);
+    OutSamples.Reserve(SW * SH);
+
+    for (int32 dy = 0; dy < SH; dy++) {
+        int32 y0 = (int64)dy * Height / SH;
+        int32 y1 = (int64)(dy + 1) * Height / SH;
+        for (int32 dx = 0; dx < SW; dx++) {
+            int32 x0 = (int64)dx * Width / SW;
+            int32 x1 = (int64)(dx + 1) * Width / SW;
+
+            FLinearColor sum = FLinearColor(0, 0, 0, 0);
+            for (int32 y = y0; y < y1; y++) {
+                const FLinearColor* row = Pixels.GetData() + (int64)y * Width;
+                for (int32 x = x0; x < x1; x++) {
+                    sum += row[x];
+                }
+            }
+            OutSamples.Add(sum / float((y1 - y0) * (x1 - x0)));
+        }
+    }
+}
+
+void FAdaptivePaletteQuantizer::BuildHistogram(const TArray<FLinearColor>& Samples) {
+    BinColors.Reset();
+    BinWeights.Reset();
+    BinKeys.Reset();
+
+    for (const FLinearColor& color : Samples) {
+        int32 key = HistogramKey(color);
+        int32& bin = BinLookup[key];
+        if (bin == INDEX_NONE) {
+            bin = BinColors.Num();
+            BinColors.Add(FVector3f::ZeroVector);
+            BinWeights.Add(0.f);
+            BinKeys.Add(key);
+        }
+        BinColors[bin] += ToVector(color);
+        BinWeights[bin] += 1.f;
+    }
+
+    for (int32 i = 0; i < BinColors.Num(); i++) {
+        BinColors[i] /= BinWeights[i];
+        BinLookup[BinKeys[i]] = INDEX_NONE;
+    }
+}
+
+void FAdaptivePaletteQuantizer::SeedCenters() {
+    //Deterministic farthest point seeding: heaviest bin first, then the bin with the largest weighted distance to the chosen set
+    WorkPalette.Reset();
+    if (BinColors.IsEmpty()) return;
+
+    TArray<float> minDist;
+    minDist.Init(UE_MAX_FLT, BinColors.Num());
+
+    int32 next = 0;
+    for (int32 i = 1; i < BinWeights.Num(); i++) {
+        if (BinWeights[i] > BinWeights[next]) next = i;
+    }
+
+    while (WorkPalette.Num() < Settings.PaletteSize) {
+        FVector3f center = BinColors[next];
+        WorkPalette.Add(FLinearColor(center.X, center.Y, center.Z));
+
+        float best = -1.f;
+        for (int32 i = 0; i < BinColors.Num(); i++) {
+            minDist[i] = FMath::Min(minDist[i], FVector3f::DistSquared(BinColors[i], center));
+            float score = minDist[i] * BinWeights[i];
+            if (score > best) {
+                best = score;
+                next = i;
+            }
+        }
+    }
+}
+
+void FAdaptivePaletteQuantizer::Quantize(const TArray<FLinearColor>& Samples, double PreparationSeconds) {
+    double start = FPlatformTime::Seconds();
+
+    WorkStats.FrameIndex++;
+    WorkStats.Iterations = 0;
+    WorkStats.MaxShift = 0.f;
+
+    BuildHistogram(Samples);
+    WorkStats.HistogramBins = BinColors.Num();
+
+    if (BinColors.IsEmpty()) {
+        WorkStats.Seconds = PreparationSeconds + (FPlatformTime::Seconds() - start);
+        return;
+    }
+
+    //Warm start keeps entry order, so only a warm started palette is clamped against the previous frame
+    bool bWarmStart = WorkPalette.Num() == Settings.PaletteSize;
+    if (!bWarmStart) SeedCenters();
+
+    const int32 K = WorkPalette.Num();
+    TArray<FVector3f> previous;
+    TArray<FVector3f> centers;
+    previous.Reserve(K);
+    for (const FLinearColor& color : WorkPalette) previous.Add(ToVector(color));
+    centers = previous;
+
+    TArray<FVector3f> sums;
+    TArray<float> weights;
+    TArray<float> errors;
+    errors.SetNumUninitialized(BinColors.Num());
+
+    for (int32 it = 0; it < Settings.MaxIterations; it++) {
+        sums.Init(FVector3f::ZeroVector, K);
+        weights.Init(0.f, K);
+
+        for (int32 i = 0; i < BinColors.Num(); i++) {
+            float dist = UE_MAX_FLT;
+            int32 closest = 0;
+            for (int32 k = 0; k < K; k++) {
+                float d = FVector3f::DistSquared(BinColors[i], centers[k]);
+                if (d < dist) {
+                    dist = d;
+                    closest = k;
+                }
+            }
+            sums[closest] += BinColors[i] * BinWeights[i];
+            weights[closest] += BinWeights[i];
+            errors[i] = dist * BinWeights[i];
+        }
+
+        float moved = 0.f;
+        for (int32 k = 0; k < K; k++) {
+            FVector3f updated = centers[k];
+            if (weights[k] > 0.f) {
+                updated = sums[k] / weights[k];
+            } else {
+                //Empty cluster (scene change or duplicate seed): move it to the worst represented bin.
+                //The final MaxShiftPerFrame clamp turns this into a bounded step toward that bin
+                int32 worst = INDEX_NONE;
+                float worstError = 0.f;
+                for (int32 i = 0; i < errors.Num(); i++) {
+                    if (errors[i] > worstError) {
+                        worstError = errors[i];
+                        worst = i;
+                    }
+                }
+                if (worst == INDEX_NONE) continue;
+                errors[worst] = 0.f;
+                updated = BinColors[worst];
+            }
+            moved = FMath::Max(moved, FVector3f::Dist(updated, centers[k]));
+            centers[k] = updated;
+        }
+
+        WorkStats.Iterations++;
+        if (moved < ConvergenceEpsilon) break;
+        if (FPlatformTime::Seconds() - start >= Settings.TimeBudgetSeconds) break;
+    }
+
+    for (int32 k = 0; k < K; k++) {
+        FVector3f delta = centers[k] - previous[k];
+        float length = delta.Length();
+        if (bWarmStart && length > Settings.MaxShiftPerFrame) {
+            centers[k] = previous[k] + delta * (Settings.MaxShiftPerFrame / length);
+            length = Settings.MaxShiftPerFrame;
+        }
+        if (bWarmStart) WorkStats.MaxShift = FMath::Max(WorkStats.MaxShift, length);
+        WorkPalette[k] = FLinearColor(centers[k].X, centers[k].Y, centers[k].Z);
+    }
+
+    WorkSearchPalette = UPixelizationMaterialsBPLibrary::ConvertPaletteForSearch(WorkPalette, Settings.ColorSpace, Settings.SearchType);
+    UpdateDitherLUT(start);
+    WorkStats.Seconds = PreparationSeconds + (FPlatformTime::Seconds() - start);
+}
+
+void FAdaptivePaletteQuantizer::UpdateDitherLUT(double StartSeconds) {
+    WorkStats.LUTCells = 0;
+
+    if (LUTCursor == INDEX_NONE) {
+        LUTPalette = WorkPalette;
+        LUTContext = FPaletteSearchContext(WorkSearchPalette, Settings.SearchType, Settings.ColorSpace);
+        WorkDitherLUT.SetNumZeroed(DitherLUTWidth * DitherLUTHeight);
+        LUTCursor = 0;
+    }
+
+    //Shares TimeBudgetSeconds with k-means, one chunk always runs so the rebuild cannot stall
+    do {
+        int32 count = FMath::Min(LUTChunkCells, DitherLUTCells - LUTCursor);
+        BuildDitherLUTCells(LUTPalette, LUTContext, LUTCursor, count, WorkDitherLUT);
+        LUTCursor += count;
+        WorkStats.LUTCells += count;
+    } while (LUTCursor < DitherLUTCells && FPlatformTime::Seconds() - StartSeconds < Settings.TimeBudgetSeconds);
+
+    if (LUTCursor == DitherLUTCells) {
+        LUTCursor = INDEX_NONE;
+        bWorkLUTReady = true;
+    }
+}
@@ -0,0 +1,307 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PaletteSearch.h"
+
+namespace {
+    //Queries are processed in blocks with the query loop innermost, so the compiler can vectorize across targets.
+    //Comparisons are done in the same mixed float / double precision as the scalar functions to keep results identical,
+    //selects are per component so they stay branch free
+    const int32 QueryBlock = 16;
+
+    //Targets of a block as separate X / Y / Z arrays, so the query loops read contiguous doubles
+    void SplitTargets(const FVector* Targets, int32 Count, double* X, double* Y, double* Z) {
+        for (int32 q = 0; q < Count; q++) {
+            X[q] = Targets[q].X;
+            Y[q] = Targets[q].Y;
+            Z[q] = Targets[q].Z;
+        }
+    }
+
+    void KernelClosestOffset(const FPaletteSearchContext& Context, const FVector* Targets, FPaletteSearchResult* Out, int32 Count) {
+        const int32 num = Context.Palette.Num();
+        const FVector* palette = Context.Palette.GetData();
+
+        float dist[QueryBlock];
+        int32 indexA[QueryBlock];
+        for (int32 q = 0; q < Count; q++) {
+            dist[q] = UE_MAX_FLT;
+            indexA[q] = 0;
+        }
+
+        double tx[QueryBlock], ty[QueryBlock], tz[QueryBlock];
+        SplitTargets(Targets, Count, tx, ty, tz);
+
+        for (int32 i = 0; i < num; i++) {
+            const double px = palette[i].X, py = palette[i].Y, pz = palette[i].Z;
+            for (int32 q = 0; q < Count; q++) {
+                //FVector::Dist, per component
+                double dx = px - tx[q], dy = py - ty[q], dz = pz - tz[q];
+                double d = FMath::Sqrt(dx * dx + dy * dy + dz * dz);
+                bool closer = d < dist[q];
+                dist[q] = closer ? float(d) : dist[q];
+                indexA[q] = closer ? i : indexA[q];
+            }
+        }
+
+        //Second pass depends on colorA, offsets are looked up from the precomputed row
+        for (int32 q = 0; q < Count; q++) {
+            const int32 a = indexA[q];
+            const FVector* directions = Context.OffsetDirections.GetData() + a * num;
+            FVector tgt = (Targets[q] - palette[a]).GetUnsafeNormal();
+
+            float offsetDist = UE_MAX_FLT;
+            int32 b = 0;
+            for (int32 j = 0; j < num; j++) {
+                double d = FVector::Dist(tgt, directions[j]);
+                bool closer = d < offsetDist;
+                offsetDist = closer ? float(d) : offsetDist;
+                b = closer ? j : b;
+            }
+
+            double angle = tgt.Dot(directions[b]);
+            Out[q].IndexA = a;
+            Out[q].IndexB = b;
+            Out[q].Blend = ((Targets[q] - palette[a]).Length() * angle) / Context.OffsetLengths[a * num + b];
+        }
+    }
+
+    void KernelClosestLine(const FPaletteSearchContext& Context, const FVector* Targets, FPaletteSearchResult* Out, int32 Count) {
+        const int32 num = Context.Palette.Num();
+        const FVector* palette = Context.Palette.GetData();
+
+        float dist[QueryBlock];
+        int32 indexA[QueryBlock];
+        int32 indexB[QueryBlock];
+        for (int32 q = 0; q < Count; q++) {
+            dist[q] = UE_MAX_FLT;
+            indexA[q] = 0;
+            indexB[q] = 0;
+        }
+
+        double tx[QueryBlock], ty[QueryBlock], tz[QueryBlock];
+        SplitTargets(Targets, Count, tx, ty, tz);
+
+        for (int32 i = 0; i < num; i++) {
+            const double sx = palette[i].X, sy = palette[i].Y, sz = palette[i].Z;
+            for (int32 j = 0; j < num; j++) {
+                const double ex = palette[j].X, ey = palette[j].Y, ez = palette[j].Z;
+                const FVector& segment = Context.Segments[i * num + j];
+                const double gx = segment.X, gy = segment.Y, gz = segment.Z;
+                const double dot2 = Context.SegmentLengthsSquared[i * num + j];
+
+                for (int32 q = 0; q < Count; q++) {
+                    //Same steps as FMath::PointDistToSegment, per component with the segment hoisted out of the query loop
+                    double dot1 = (tx[q] - sx) * gx + (ty[q] - sy) * gy + (tz[q] - sz) * gz;
+                    double t = dot1 / dot2;
+                    double cx = sx + gx * t, cy = sy + gy * t, cz = sz + gz * t;
+                    cx = dot2 <= dot1 ? ex : cx;
+                    cy = dot2 <= dot1 ? ey : cy;
+                    cz = dot2 <= dot1 ? ez : cz;
+                    cx = dot1 <= 0 ? sx : cx;
+                    cy = dot1 <= 0 ? sy : cy;
+                    cz = dot1 <= 0 ? sz : cz;
+
+                    double dx = tx[q] - cx, dy = ty[q] - cy, dz = tz[q] - cz;
+                    float d = FMath::Sqrt(dx * dx + dy * dy + dz * dz);
+                    bool closer = d < dist[q];
+                    dist[q] = closer ? d : dist[q];
+                    indexA[q] = closer ? i : indexA[q];
+                    indexB[q] = closer ? j : indexB[q];
+                }
+            }
+        }
+
+        for (int32 q = 0; q < Count; q++) {
+            const FVector& colorA = palette[indexA[q]];
+            const FVector& colorB = palette[indexB[q]];
+            Out[q].IndexA = indexA[q];
+            Out[q].IndexB = indexB[q];
+            Out[q].Blend = (Targets[q] - colorB).Length() / ((Targets[q] - colorA).Length() + (Targets[q] - colorB).Length());
+        }
+    }
+
+    template<EAxis::Type Axis>
+    void KernelClosestOnAxis(const FPaletteSearchContext& Context, const FVector* Targets, FPaletteSearchResult* Out, int32 Count) {
+        const int32 num = Context.Palette.Num();
+        const float* values = Context.AxisValues.GetData();
+        const float* keys = Context.AxisKeys.GetData();
+
+        float tgt[QueryBlock];
+        float posA[QueryBlock];
+        float posB[QueryBlock];
+        int32 indexA[QueryBlock];
+        int32 indexB[QueryBlock];
+        for (int32 q = 0; q < Count; q++) {
+            tgt[q] = Targets[q].GetComponentForAxis(Axis);
+            posA[q] = Context.AxisMin;
+            posB[q] = Context.AxisMax;
+            indexA[q] = Context.AxisMinIndex;
+            indexB[q] = Context.AxisMaxIndex;
+        }
+
+        for (int32 i = 0; i < num; i++) {
+            const float v = values[i];
+            const float key = keys[i];
+            for (int32 q = 0; q < Count; q++) {
+                bool vLess = key < tgt[q];
+                bool takeA = vLess & (v > posA[q]);
+                bool takeB = !vLess & (v < posB[q]);
+                posA[q] = takeA ? v : posA[q];
+                indexA[q] = takeA ? i : indexA[q];
+                posB[q] = takeB ? v : posB[q];
+                indexB[q] = takeB ? i : indexB[q];
+            }
+        }
+
+        for (int32 q = 0; q < Count; q++) {
+            Out[q].IndexA = indexA[q];
+            Out[q].IndexB = indexB[q];
+            Out[q].Blend = (tgt[q] - posA[q]) / (posB[q] - posA[q]);
+        }
+    }
+}
+
+FPaletteSearchContext::FPaletteSearchContext(const TArray<FVector>& InPalette, EColorSearchType InSearchType, EColorSpace InColorSpace)
+    : Palette(InPalette), SearchType(InSearchType), ColorSpace(InColorSpace) {
+    const int32 num = Palette.Num();
+
+    EAxis::Type axis = EAxis::None;
+    switch (SearchType) {
+    case ClosestLine:
+        Kernel = &KernelClosestLine;
+        Segments.Reserve(num * num);
+        SegmentLengthsSquared.Reserve(num * num);
+        for (const FVector& start : Palette) {
+            for (const FVector& end : Palette) {
+                FVector segment = end - start;
+                Segments.Add(segment);
+                SegmentLengthsSquared.Add(segment | segment);
+            }
+        }
+        break;
+    case ClosestX:
+        Kernel = &KernelClosestOnAxis<EAxis::X>;
+        axis = EAxis::X;
+        break;
+    case ClosestY:
+        Kernel = &KernelClosestOnAxis<EAxis::Y>;
+        axis = EAxis::Y;
+        break;
+    case ClosestZ:
+        Kernel = &KernelClosestOnAxis<EAxis::Z>;
+        axis = EAxis::Z;
+        break;
+    case ClosestOffset:
+    default:
+        Kernel = &KernelClosestOffset;
+        OffsetDirections.Reserve(num * num);
+        OffsetLengths.Reserve(num * num);
+        for (const FVector& colorA : Palette) {
+            for (const FVector& color : Palette) {
+                OffsetDirections.Add((color - colorA).GetUnsafeNormal());
+                OffsetLengths.Add((color - colorA).Length());
+            }
+        }
+        break;
+    }
+
+    if (axis == EAxis::None) return;
+
+    //First pass of findClosestOnAxis does not depend on the target
+    AxisValues.Reserve(num);
+    for (int32 i = 0; i < num; i++) {
+        float v = Palette[i].GetComponentForAxis(axis);
+        AxisValues.Add(v);
+        if (v > AxisMax) {
+            AxisMax = v;
+            AxisMaxIndex = i;
+        }
+        if (v < AxisMin) {
+            AxisMin = v;
+            AxisMinIndex = i;
+        }
+    }
+
+    const bool bScaled = ColorSpace == EColorSpace::HSV && axis != EAxis::X;
+    AxisKeys.Reserve(num);
+    for (float v : AxisValues) {
+        AxisKeys.Add(bScaled ? v / AxisMax : v);
+    }
+}
+
+void FindClosestBatch(const FPaletteSearchContext& Context, TConstArrayView<FVector> Targets, TArrayView<FPaletteSearchResult> Out) {
+    check(Out.Num() >= Targets.Num());
+    if (!Context.Kernel || Context.Palette.IsEmpty()) return;
+
+    for (int32 start = 0; start < Targets.Num(); start += QueryBlock) {
+        int32 count = FMath::Min(QueryBlock, Targets.Num() - start);
+        Context.Kernel(Context, Targets.GetData() + start, Out.GetData() + start, count);
+    }
+}
+
+void FindClosestBatch(const FPaletteSearchContext& Context, TConstArrayView<FVector3f> Targets, TArrayView<FPaletteSearchResult> Out) {
+    check(Out.Num() >= Targets.Num());
+    if (!Context.Kernel || Context.Palette.IsEmpty()) return;
+
+    FVector block[QueryBlock];
+    for (int32 start = 0; start < Targets.Num(); start += QueryBlock) {
+        int32 count = FMath::Min(QueryBlock, Targets.Num() - start);
+        for (int32 q = 0; q < count; q++) {
+            block[q] = FVector(Targets[start + q]);
+        }
+        Context.Kernel(Context, block, Out.GetData() + start, count);
+    }
+}
+
+void ResolveNonFiniteTargets(const TArray<FLinearColor>& Palette, TConstArrayView<FVector> Targets, TArrayView<FPaletteSearchResult> Results) {
+    check(Results.Num() >= Targets.Num());
+    int32 darkest = INDEX_NONE;
+
+    for (int32 q = 0; q < Targets.Num(); q++) {
+        if (!Targets[q].ContainsNaN()) continue;
+
+        if (darkest == INDEX_NONE) {
+            darkest = 0;
+            for (int32 i = 1; i < Palette.Num(); i++) {
+                if (Palette[i].GetLuminance() < Palette[darkest].GetLuminance()) darkest = i;
+            }
+        }
+        Results[q] = { darkest, darkest, 0.f };
+    }
+}
+
+void BuildDitherLUT(const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, TArray<FFloat16Color>& OutLUT) {
+    OutLUT.SetNumZeroed(DitherLUTWidth * DitherLUTHeight);
+    BuildDitherLUTCells(Palette, Context, 0, DitherLUTCells, OutLUT);
+}
+
+void BuildDitherLUTCells(const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, int32 FirstCell, int32 NumCells, TArray<FFloat16Color>& OutLUT) {
+    check(OutLUT.Num() == DitherLUTWidth * DitherLUTHeight);
+    if (Palette.IsEmpty() || Palette.Num() != Context.Palette.Num()) return;
+
+    FirstCell = FMath::Clamp(FirstCell, 0, DitherLUTCells);
+    NumCells = FMath::Clamp(NumCells, 0, DitherLUTCells - FirstCell);
+    const float step = 1.f / (DitherLUTResolution - 1);
+
+    TArray<FVector> targets;
+    targets.SetNumUninitialized(NumCells);
+    for (int32 i = 0; i < NumCells; i++) {
+        const int32 x = (FirstCell + i) % DitherLUTWidth;
+        const int32 y = (FirstCell + i) / DitherLUTWidth;
+        FLinearColor color = FLinearColor((x % DitherLUTResolution) * step, y * step, (x / DitherLUTResolution) * step);
+        targets[i] = UPixelizationMaterialsBPLibrary::ConvertColorForSearch(color, Context.ColorSpace, Context.SearchType);
+    }
+
+    TArray<FPaletteSearchResult> results;
+    results.SetNum(NumCells);
+    FindClosestBatch(Context, targets, results);
+    ResolveNonFiniteTargets(Palette, targets, results);
+
+    for (int32 i = 0; i < NumCells; i++) {
+        const FPaletteSearchResult& result = results[i];
+        const int32 cell = FirstCell + i;
+        OutLUT[cell] = FFloat16Color(Palette[result.IndexA]);
+        OutLUT[cell + DitherLUTCells] = FFloat16Color(Palette[result.IndexB]);
+        OutLUT[cell + DitherLUTCells * 2] = FFloat16Color(FLinearColor(result.Blend, result.Blend, result.Blend));
+    }
+}
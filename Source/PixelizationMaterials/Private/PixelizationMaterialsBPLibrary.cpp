@@ -2,6 +2,7 @@
 
 #include "PixelizationMaterialsBPLibrary.h"
 #include "PixelizationMaterials.h"
+#include "PaletteSearch.h"
 
 
 
@@ -63,7 +64,11 @@ float ReverseFloat(const float inFloat) {
 }
 
 bool UPixelizationMaterialsBPLibrary::ReadPalleteFromFile(TArray<FLinearColor>& Palette, FString& PalleteName) {
-    FString filePath = OpenFileDialog();
+    return ReadPalleteFromPath(OpenFileDialog(), Palette, PalleteName);
+}
+
+bool UPixelizationMaterialsBPLibrary::ReadPalleteFromPath(const FString& FilePath, TArray<FLinearColor>& Palette, FString& PalleteName) {
+    FString filePath = FilePath;
 
     FString fileContent = "";
     if (!FFileHelper::LoadFileToString(fileContent, *filePath)) return false;
@@ -531,8 +536,97 @@ void UPixelizationMaterialsBPLibrary::findClosestSelectSearchType(TArray<FVector
     }
 }
 
+void UPixelizationMaterialsBPLibrary::findClosestBatchSelectSearchType(const TArray<FVector>& palette, const TArray<FVector>& targetColors, EColorSearchType searchType, EColorSpace ColorSpace, TArray<FVector>& colorsA, TArray<FVector>& colorsB, TArray<float>& blends) {
+    colorsA.Reset();
+    colorsB.Reset();
+    blends.Reset();
+    if (palette.IsEmpty()) return;
+
+    FPaletteSearchContext context(palette, searchType, ColorSpace);
+    TArray<FPaletteSearchResult> results;
+    results.SetNum(targetColors.Num());
+    FindClosestBatch(context, targetColors, results);
+
+    colorsA.Reserve(results.Num());
+    colorsB.Reserve(results.Num());
+    blends.Reserve(results.Num());
+    for (const FPaletteSearchResult& result : results) {
+        colorsA.Add(palette[result.IndexA]);
+        colorsB.Add(palette[result.IndexB]);
+        blends.Add(result.Blend);
+    }
+}
 
+//----
 
+void UPixelizationMaterialsBPLibrary::PalettizePixels(TArray<FColor>& Pixels, int32 Width, int32 Height, const TArray<FLinearColor>& Palette, EColorSpace ColorSpace, EColorSearchType SearchType, int32 PixelSize, bool bDither) {
+    if (Palette.IsEmpty()) return;
+    PalettizePixels(Pixels, Width, Height, Palette, FPaletteSearchContext(ConvertPaletteForSearch(Palette, ColorSpace, SearchType), SearchType, ColorSpace), PixelSize, bDither);
+}
 
+void UPixelizationMaterialsBPLibrary::PalettizePixels(TArray<FColor>& Pixels, int32 Width, int32 Height, const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, int32 PixelSize, bool bDither) {
+    if (Palette.IsEmpty() || Palette.Num() != Context.Palette.Num() || Width <= 0 || Height <= 0 || Pixels.Num() < Width * Height) return;
+    const EColorSpace ColorSpace = Context.ColorSpace;
+    const EColorSearchType SearchType = Context.SearchType;
+
+    //4x4 ordered dither thresholds, centered in (0, 1)
+    static const float Bayer[16] = {
+         0.5f / 16.f,  8.5f / 16.f,  2.5f / 16.f, 10.5f / 16.f,
+        12.5f / 16.f,  4.5f / 16.f, 14.5f / 16.f,  6.5f / 16.f,
+         3.5f / 16.f, 11.5f / 16.f,  1.5f / 16.f,  9.5f / 16.f,
+        15.5f / 16.f,  7.5f / 16.f, 13.5f / 16.f,  5.5f / 16.f,
+    };
+
+    PixelSize = FMath::Max(PixelSize, 1);
+    const int32 blocksX = FMath::DivideAndRoundUp(Width, PixelSize);
+    const int32 blocksY = FMath::DivideAndRoundUp(Height, PixelSize);
+
+    TArray<FVector> targets;
+    targets.Reserve(blocksX * blocksY);
+    for (int32 by = 0; by < Height; by += PixelSize) {
+        int32 y1 = FMath::Min(by + PixelSize, Height);
+        for (int32 bx = 0; bx < Width; bx += PixelSize) {
+            int32 x1 = FMath::Min(bx + PixelSize, Width);
+
+            //Weighted by alpha so fully transparent texels (often garbage RGB) do not bleed into the block color
+            FLinearColor sum = FLinearColor(0, 0, 0, 0);
+            FLinearColor weightedSum = FLinearColor(0, 0, 0, 0);
+            float alphaSum = 0.f;
+            for (int32 y = by; y < y1; y++) {
+                for (int32 x = bx; x < x1; x++) {
+                    FLinearColor color = FLinearColor(Pixels[y * Width + x]);
+                    sum += color;
+                    weightedSum += color * color.A;
+                    alphaSum += color.A;
+                }
+            }
+            FLinearColor average = alphaSum > 0.f ? weightedSum / alphaSum : sum / float((y1 - by) * (x1 - bx));
+            targets.Add(ConvertColorForSearch(average, ColorSpace, SearchType));
+        }
+    }
+
+    TArray<FPaletteSearchResult> results;
+    results.SetNum(targets.Num());
+    FindClosestBatch(Context, targets, results);
+    ResolveNonFiniteTargets(Palette, targets, results);
+
+    for (int32 block = 0; block < results.Num(); block++) {
+        const int32 bx = (block % blocksX) * PixelSize;
+        const int32 by = (block / blocksX) * PixelSize;
+
+        //ClosestLine returns the weight of colorA, the other searches the weight of colorB
+        float weightB = SearchType == ClosestLine ? 1.f - results[block].Blend : results[block].Blend;
+        if (!FMath::IsFinite(weightB)) weightB = 0.f;
 
+        float threshold = bDither ? Bayer[((by / PixelSize) % 4) * 4 + (bx / PixelSize) % 4] : 0.5f;
+        int32 index = weightB > threshold ? results[block].IndexB : results[block].IndexA;
+        FColor result = Palette[index].ToFColorSRGB();
 
+        for (int32 y = by; y < FMath::Min(by + PixelSize, Height); y++) {
+            for (int32 x = bx; x < FMath::Min(bx + PixelSize, Width); x++) {
+                FColor& pixel = Pixels[y * Width + x];
+                pixel = FColor(result.R, result.G, result.B, pixel.A);
+            }
+        }
+    }
+}
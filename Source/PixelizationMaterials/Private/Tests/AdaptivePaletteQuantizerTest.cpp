@@ -0,0 +1,199 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AdaptivePaletteQuantizer.h"
+#include "PaletteSearch.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+    const int32 FrameWidth = 64;
+    const int32 FrameHeight = 36;
+
+    //Four solid quadrants, one color each
+    TArray<FLinearColor> MakeQuadrantFrame(const FLinearColor (&Colors)[4]) {
+        TArray<FLinearColor> pixels;
+        pixels.SetNumUninitialized(FrameWidth * FrameHeight);
+        for (int32 y = 0; y < FrameHeight; y++) {
+            for (int32 x = 0; x < FrameWidth; x++) {
+                int32 quadrant = (y < FrameHeight / 2 ? 0 : 2) + (x < FrameWidth / 2 ? 0 : 1);
+                pixels[y * FrameWidth + x] = Colors[quadrant];
+            }
+        }
+        return pixels;
+    }
+
+    float DistanceToPalette(const TArray<FLinearColor>& Palette, const FLinearColor& Color) {
+        float dist = UE_MAX_FLT;
+        for (const FLinearColor& entry : Palette) {
+            dist = FMath::Min(dist, FVector3f::Dist(FVector3f(entry.R, entry.G, entry.B), FVector3f(Color.R, Color.G, Color.B)));
+        }
+        return dist;
+    }
+
+    //Smooth gradient, enough histogram bins for large palettes
+    TArray<FLinearColor> MakeGradientFrame() {
+        TArray<FLinearColor> pixels;
+        pixels.SetNumUninitialized(FrameWidth * FrameHeight);
+        for (int32 y = 0; y < FrameHeight; y++) {
+            for (int32 x = 0; x < FrameWidth; x++) {
+                pixels[y * FrameWidth + x] = FLinearColor(float(x) / FrameWidth, float(y) / FrameHeight, float(x + y) / (FrameWidth + FrameHeight));
+            }
+        }
+        return pixels;
+    }
+
+    FAdaptivePaletteSettings MakeTestSettings() {
+        //Generous time budget so results do not depend on machine speed
+        FAdaptivePaletteSettings settings;
+        settings.PaletteSize = 4;
+        settings.SampleSize = FIntPoint(FrameWidth, FrameHeight);
+        settings.MaxIterations = 16;
+        settings.TimeBudgetSeconds = 1.f;
+        settings.MaxShiftPerFrame = 0.02f;
+        return settings;
+    }
+
+    const FLinearColor DayColors[4] = {
+        FLinearColor(0.9f, 0.1f, 0.1f), FLinearColor(0.1f, 0.9f, 0.1f),
+        FLinearColor(0.1f, 0.1f, 0.9f), FLinearColor(0.9f, 0.9f, 0.1f),
+    };
+
+    const FLinearColor NightColors[4] = {
+        FLinearColor(0.02f, 0.02f, 0.08f), FLinearColor(0.05f, 0.1f, 0.05f),
+        FLinearColor(0.2f, 0.05f, 0.05f), FLinearColor(0.f, 0.f, 0.f),
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdaptivePaletteConvergenceTest, "PixelizationMaterials.AdaptivePalette.Convergence",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAdaptivePaletteConvergenceTest::RunTest(const FString& Parameters) {
+    FAdaptivePaletteQuantizer quantizer(MakeTestSettings());
+    TArray<FLinearColor> frame = MakeQuadrantFrame(DayColors);
+
+    quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+    TestEqual(TEXT("Palette size"), quantizer.GetPalette().Num(), 4);
+    TestEqual(TEXT("Search palette size"), quantizer.GetSearchPalette().Num(), 4);
+    for (const FLinearColor& color : DayColors) {
+        TestTrue(TEXT("Scene color has a palette entry"), DistanceToPalette(quantizer.GetPalette(), color) < 0.01f);
+    }
+
+    //The LUT handed to the material only contains palette colors
+    const TArray<FFloat16Color>& lut = quantizer.GetDitherLUT();
+    if (TestEqual(TEXT("LUT size"), lut.Num(), DitherLUTWidth * DitherLUTHeight)) {
+        for (int32 i = 0; i < DitherLUTWidth * DitherLUTResolution * 2; i++) {
+            if (DistanceToPalette(quantizer.GetPalette(), FLinearColor(lut[i])) > 0.01f) {
+                AddError(FString::Printf(TEXT("LUT texel %d is not a palette color"), i));
+                break;
+            }
+        }
+    }
+
+    //A converged palette must not drift on an unchanged scene
+    for (int32 i = 0; i < 10; i++) {
+        quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+        TestTrue(TEXT("Static scene is stable"), quantizer.GetStats().MaxShift <= 1e-4f);
+    }
+
+    AddInfo(FString::Printf(TEXT("Per-frame cost %.3f ms, %d iterations"), quantizer.GetStats().Seconds * 1000.f, quantizer.GetStats().Iterations));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdaptivePaletteSceneChangeTest, "PixelizationMaterials.AdaptivePalette.SceneChange",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAdaptivePaletteSceneChangeTest::RunTest(const FString& Parameters) {
+    const FAdaptivePaletteSettings settings = MakeTestSettings();
+    FAdaptivePaletteQuantizer quantizer(settings);
+
+    TArray<FLinearColor> day = MakeQuadrantFrame(DayColors);
+    TArray<FLinearColor> night = MakeQuadrantFrame(NightColors);
+
+    for (int32 i = 0; i < 30; i++) {
+        quantizer.ProcessFrame(day, FrameWidth, FrameHeight);
+    }
+
+    //Every entry has to move at most MaxShiftPerFrame, and entries that lose all their bins must still follow the scene
+    for (int32 i = 0; i < 200; i++) {
+        TArray<FLinearColor> previous = quantizer.GetPalette();
+        quantizer.ProcessFrame(night, FrameWidth, FrameHeight);
+
+        const TArray<FLinearColor>& palette = quantizer.GetPalette();
+        if (!TestEqual(TEXT("Palette size is stable"), palette.Num(), previous.Num())) return false;
+
+        TestTrue(TEXT("Reported shift is bounded"), quantizer.GetStats().MaxShift <= settings.MaxShiftPerFrame + 1e-5f);
+        for (int32 k = 0; k < palette.Num(); k++) {
+            float shift = FVector3f::Dist(FVector3f(palette[k].R, palette[k].G, palette[k].B), FVector3f(previous[k].R, previous[k].G, previous[k].B));
+            TestTrue(TEXT("Entry shift is bounded"), shift <= settings.MaxShiftPerFrame + 1e-5f);
+        }
+    }
+
+    for (const FLinearColor& color : NightColors) {
+        TestTrue(TEXT("Palette followed the scene change"), DistanceToPalette(quantizer.GetPalette(), color) < 0.01f);
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdaptivePaletteLUTBudgetTest, "PixelizationMaterials.AdaptivePalette.LUTBudget",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAdaptivePaletteLUTBudgetTest::RunTest(const FString& Parameters) {
+    //No budget: every update builds exactly one chunk, so a ClosestLine LUT takes DitherLUTCells / chunk updates
+    FAdaptivePaletteSettings settings = MakeTestSettings();
+    settings.PaletteSize = 64;
+    settings.MaxIterations = 1;
+    settings.TimeBudgetSeconds = 0.f;
+    settings.SearchType = EColorSearchType::ClosestLine;
+
+    FAdaptivePaletteQuantizer quantizer(settings);
+    TArray<FLinearColor> frame = MakeGradientFrame();
+
+    quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+    const int32 chunk = quantizer.GetStats().LUTCells;
+    TestTrue(TEXT("LUT rebuild is split"), chunk > 0 && chunk < DitherLUTCells);
+    TestEqual(TEXT("No LUT before the rebuild finishes"), quantizer.GetDitherLUTVersion(), 0);
+
+    int32 updates = 1;
+    while (quantizer.GetDitherLUTVersion() == 0 && updates < DitherLUTCells) {
+        quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+        TestEqual(TEXT("One chunk per update"), quantizer.GetStats().LUTCells, chunk);
+        updates++;
+    }
+    TestEqual(TEXT("LUT finished after all chunks"), updates, DitherLUTCells / chunk);
+    TestEqual(TEXT("LUT size"), quantizer.GetDitherLUT().Num(), DitherLUTWidth * DitherLUTHeight);
+
+    //Worst case of the smallest step: one ClosestLine chunk against the largest palette
+    settings.PaletteSize = 256;
+    quantizer.SetSettings(settings);
+    quantizer.Reset();
+    double worst = 0.;
+    for (int32 i = 0; i < 4; i++) {
+        quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+        worst = FMath::Max(worst, (double)quantizer.GetStats().Seconds);
+    }
+    AddInfo(FString::Printf(TEXT("ClosestLine, 256 colors, zero budget: worst update %.3f ms for %d LUT cells"), worst * 1000., quantizer.GetStats().LUTCells));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAdaptivePaletteSettingsTest, "PixelizationMaterials.AdaptivePalette.Settings",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FAdaptivePaletteSettingsTest::RunTest(const FString& Parameters) {
+    FAdaptivePaletteSettings settings = MakeTestSettings();
+    settings.PaletteSize = 0;
+    settings.MaxIterations = 0;
+    settings.SampleSize = FIntPoint(0, -1);
+
+    FAdaptivePaletteQuantizer quantizer(settings);
+    TestEqual(TEXT("PaletteSize is clamped"), quantizer.GetSettings().PaletteSize, 2);
+    TestEqual(TEXT("MaxIterations is clamped"), quantizer.GetSettings().MaxIterations, 1);
+
+    TArray<FLinearColor> frame = MakeQuadrantFrame(DayColors);
+    quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+    quantizer.ProcessFrame(frame, FrameWidth, FrameHeight);
+    TestEqual(TEXT("Palette uses the clamped size"), quantizer.GetPalette().Num(), 2);
+    return true;
+}
+
+#endif
@@ -0,0 +1,142 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PaletteSearch.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+    //Bitwise so -0 / +0 and palette entries with NaN components (black in CIELUV) are told apart
+    bool BitsEqual(const FVector& A, const FVector& B) {
+        return FMemory::Memcmp(&A, &B, sizeof(FVector)) == 0;
+    }
+
+    //Zero-length segments and offsets give NaN blends, the NaN sign is not meaningful
+    bool BitsEqual(float A, float B) {
+        return (FMath::IsNaN(A) && FMath::IsNaN(B)) || FMemory::Memcmp(&A, &B, sizeof(float)) == 0;
+    }
+
+    FLinearColor RandomColor(FRandomStream& Random) {
+        return FLinearColor(Random.GetFraction(), Random.GetFraction(), Random.GetFraction());
+    }
+
+    //Random palette plus the degenerate cases: duplicate entries (zero-length segments and offsets) and black
+    TArray<FLinearColor> MakePalette(FRandomStream& Random, int32 Num) {
+        TArray<FLinearColor> palette;
+        for (int32 i = 0; i < Num; i++) {
+            palette.Add(RandomColor(Random));
+        }
+        if (Num >= 4) {
+            palette[Num - 1] = palette[0];
+            palette[Num - 2] = palette[1];
+            palette[Num - 3] = FLinearColor::Black;
+        }
+        return palette;
+    }
+
+    //Random targets plus every palette entry itself and black
+    TArray<FVector> MakeTargets(FRandomStream& Random, const TArray<FLinearColor>& Palette, EColorSpace ColorSpace, EColorSearchType SearchType) {
+        TArray<FVector> targets;
+        for (int32 i = 0; i < 200; i++) {
+            targets.Add(UPixelizationMaterialsBPLibrary::ConvertColorForSearch(RandomColor(Random), ColorSpace, SearchType));
+        }
+        for (const FLinearColor& color : Palette) {
+            targets.Add(UPixelizationMaterialsBPLibrary::ConvertColorForSearch(color, ColorSpace, SearchType));
+        }
+        targets.Add(UPixelizationMaterialsBPLibrary::ConvertColorForSearch(FLinearColor::Black, ColorSpace, SearchType));
+        return targets;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPaletteSearchBatchTest, "PixelizationMaterials.PaletteSearch.BatchMatchesScalar",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPaletteSearchBatchTest::RunTest(const FString& Parameters) {
+    const EColorSearchType searchTypes[] = { ClosestX, ClosestY, ClosestZ, ClosestLine, ClosestOffset };
+    const EColorSpace colorSpaces[] = { RGB, HSV, XYZ, CIELUV };
+    const int32 paletteSizes[] = { 1, 2, 7, 16, 33 };
+
+    FRandomStream random(1337);
+    int32 mismatches = 0;
+    int32 queries = 0;
+
+    for (EColorSearchType searchType : searchTypes) {
+        for (EColorSpace colorSpace : colorSpaces) {
+            for (int32 paletteSize : paletteSizes) {
+                TArray<FLinearColor> palette = MakePalette(random, paletteSize);
+                TArray<FVector> searchPalette = UPixelizationMaterialsBPLibrary::ConvertPaletteForSearch(palette, colorSpace, searchType);
+                TArray<FVector> targets = MakeTargets(random, palette, colorSpace, searchType);
+
+                FPaletteSearchContext context(searchPalette, searchType, colorSpace);
+                TArray<FPaletteSearchResult> results;
+                results.SetNum(targets.Num());
+                FindClosestBatch(context, targets, results);
+
+                for (int32 q = 0; q < targets.Num(); q++) {
+                    FVector colorA = searchPalette[0];
+                    FVector colorB = searchPalette[0];
+                    float blend = 0.f;
+                    UPixelizationMaterialsBPLibrary::findClosestSelectSearchType(searchPalette, targets[q], searchType, colorSpace, colorA, colorB, blend);
+
+                    queries++;
+                    if (BitsEqual(colorA, searchPalette[results[q].IndexA]) && BitsEqual(colorB, searchPalette[results[q].IndexB]) && BitsEqual(blend, results[q].Blend)) continue;
+
+                    if (mismatches++ < 10) {
+                        AddError(FString::Printf(TEXT("%s / %s, %d colors, target %s: scalar (%s, %s, %f) batch (%s, %s, %f)"),
+                            *StaticEnum<EColorSearchType>()->GetNameStringByValue(searchType), *StaticEnum<EColorSpace>()->GetNameStringByValue(colorSpace),
+                            paletteSize, *targets[q].ToString(), *colorA.ToString(), *colorB.ToString(), blend,
+                            *searchPalette[results[q].IndexA].ToString(), *searchPalette[results[q].IndexB].ToString(), results[q].Blend));
+                    }
+                }
+            }
+        }
+    }
+
+    TestEqual(TEXT("Batch and scalar mismatches"), mismatches, 0);
+    AddInfo(FString::Printf(TEXT("Compared %d queries"), queries));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPaletteSearchTimingTest, "PixelizationMaterials.PaletteSearch.Timing",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPaletteSearchTimingTest::RunTest(const FString& Parameters) {
+    //One DitherColorLUT worth of queries, reported only since timings depend on the machine
+    const EColorSearchType searchTypes[] = { ClosestX, ClosestLine, ClosestOffset };
+    const int32 targetCount = 4096;
+
+    FRandomStream random(7);
+    for (int32 paletteSize : { 16, 64 }) {
+        for (EColorSearchType searchType : searchTypes) {
+            TArray<FLinearColor> palette = MakePalette(random, paletteSize);
+            TArray<FVector> searchPalette = UPixelizationMaterialsBPLibrary::ConvertPaletteForSearch(palette, RGB, searchType);
+            TArray<FVector> targets;
+            for (int32 i = 0; i < targetCount; i++) {
+                targets.Add(FVector(random.GetFraction(), random.GetFraction(), random.GetFraction()));
+            }
+
+            double start = FPlatformTime::Seconds();
+            for (const FVector& target : targets) {
+                FVector colorA = searchPalette[0];
+                FVector colorB = searchPalette[0];
+                float blend = 0.f;
+                UPixelizationMaterialsBPLibrary::findClosestSelectSearchType(searchPalette, target, searchType, RGB, colorA, colorB, blend);
+            }
+            double scalarSeconds = FPlatformTime::Seconds() - start;
+
+            start = FPlatformTime::Seconds();
+            FPaletteSearchContext context(searchPalette, searchType, RGB);
+            TArray<FPaletteSearchResult> results;
+            results.SetNum(targets.Num());
+            FindClosestBatch(context, targets, results);
+            double batchSeconds = FPlatformTime::Seconds() - start;
+
+            AddInfo(FString::Printf(TEXT("%s, %d colors, %d targets: scalar %.3f ms, batch (context included) %.3f ms, %.2fx"),
+                *StaticEnum<EColorSearchType>()->GetNameStringByValue(searchType), paletteSize, targetCount,
+                scalarSeconds * 1000., batchSeconds * 1000., scalarSeconds / FMath::Max(batchSeconds, 1e-9)));
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelizationMaterialsBPLibrary.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace {
+    //Odd size so PixelSize 4 leaves partial blocks on the right and bottom edges
+    const int32 ImageWidth = 18;
+    const int32 ImageHeight = 14;
+
+    //Entry 0 is the darkest
+    const FLinearColor TestPalette[5] = {
+        FLinearColor(0.02f, 0.02f, 0.02f), FLinearColor(0.8f, 0.1f, 0.1f), FLinearColor(0.1f, 0.7f, 0.2f),
+        FLinearColor(0.2f, 0.3f, 0.9f), FLinearColor(0.9f, 0.9f, 0.8f),
+    };
+
+    TArray<FLinearColor> MakePalette() {
+        return TArray<FLinearColor>(TestPalette, UE_ARRAY_COUNT(TestPalette));
+    }
+
+    TArray<FColor> MakeRandomImage(FRandomStream& Random) {
+        TArray<FColor> pixels;
+        for (int32 i = 0; i < ImageWidth * ImageHeight; i++) {
+            pixels.Add(FColor(Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255)));
+        }
+        return pixels;
+    }
+
+    bool SameRGB(const FColor& A, const FColor& B) {
+        return A.R == B.R && A.G == B.G && A.B == B.B;
+    }
+
+    bool IsPaletteColor(const FColor& Color) {
+        for (const FLinearColor& entry : TestPalette) {
+            if (SameRGB(Color, entry.ToFColorSRGB())) return true;
+        }
+        return false;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPalettizePixelsOutputTest, "PixelizationMaterials.PalettizePixels.Output",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPalettizePixelsOutputTest::RunTest(const FString& Parameters) {
+    const EColorSearchType searchTypes[] = { ClosestX, ClosestY, ClosestZ, ClosestLine, ClosestOffset };
+    const EColorSpace colorSpaces[] = { RGB, HSV, XYZ, CIELUV };
+
+    FRandomStream random(42);
+    const TArray<FLinearColor> palette = MakePalette();
+    const TArray<FColor> source = MakeRandomImage(random);
+
+    for (EColorSearchType searchType : searchTypes) {
+        for (EColorSpace colorSpace : colorSpaces) {
+            for (int32 pixelSize : { 1, 4 }) {
+                for (bool bDither : { false, true }) {
+                    const FString name = FString::Printf(TEXT("%s / %s, PixelSize %d%s"), *StaticEnum<EColorSearchType>()->GetNameStringByValue(searchType),
+                        *StaticEnum<EColorSpace>()->GetNameStringByValue(colorSpace), pixelSize, bDither ? TEXT(", dither") : TEXT(""));
+
+                    TArray<FColor> pixels = source;
+                    UPixelizationMaterialsBPLibrary::PalettizePixels(pixels, ImageWidth, ImageHeight, palette, colorSpace, searchType, pixelSize, bDither);
+
+                    bool bPaletteExact = true;
+                    bool bAlphaKept = true;
+                    bool bBlocksSnapped = true;
+                    for (int32 y = 0; y < ImageHeight; y++) {
+                        for (int32 x = 0; x < ImageWidth; x++) {
+                            const FColor& pixel = pixels[y * ImageWidth + x];
+                            bPaletteExact &= IsPaletteColor(pixel);
+                            bAlphaKept &= pixel.A == source[y * ImageWidth + x].A;
+
+                            const FColor& blockOrigin = pixels[(y / pixelSize) * pixelSize * ImageWidth + (x / pixelSize) * pixelSize];
+                            bBlocksSnapped &= SameRGB(pixel, blockOrigin);
+                        }
+                    }
+                    TestTrue(name + TEXT(": every pixel is a palette color"), bPaletteExact);
+                    TestTrue(name + TEXT(": alpha is preserved"), bAlphaKept);
+                    TestTrue(name + TEXT(": blocks have one color"), bBlocksSnapped);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPalettizePixelsBlockTest, "PixelizationMaterials.PalettizePixels.BlockAverage",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FPalettizePixelsBlockTest::RunTest(const FString& Parameters) {
+    const TArray<FLinearColor> palette = MakePalette();
+
+    //Half of the block is an opaque palette color, the other half fully transparent garbage
+    const FColor opaque = TestPalette[2].ToFColorSRGB();
+    TArray<FColor> pixels;
+    for (int32 i = 0; i < 64; i++) {
+        pixels.Add(i % 2 ? FColor(opaque.R, opaque.G, opaque.B, 255) : FColor(255, 0, 255, 0));
+    }
+    UPixelizationMaterialsBPLibrary::PalettizePixels(pixels, 8, 8, palette, RGB, ClosestOffset, 8, false);
+    for (const FColor& pixel : pixels) {
+        if (!TestTrue(TEXT("Transparent texels do not change the block color"), SameRGB(pixel, opaque))) break;
+    }
+
+    //Black cannot be searched in CIELUV and falls back to the darkest entry
+    const FColor darkest = TestPalette[0].ToFColorSRGB();
+    for (EColorSearchType searchType : { ClosestX, ClosestY, ClosestZ, ClosestLine, ClosestOffset }) {
+        TArray<FColor> black;
+        black.Init(FColor::Black, 16);
+        UPixelizationMaterialsBPLibrary::PalettizePixels(black, 4, 4, palette, CIELUV, searchType, 2, true);
+        for (const FColor& pixel : black) {
+            if (!TestTrue(TEXT("Black uses the darkest entry"), SameRGB(pixel, darkest))) break;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+
+#include "AdaptivePaletteQuantizer.h"
+
+#include "AdaptivePaletteComponent.generated.h"
+
+class UTexture2D;
+class UTextureRenderTarget2D;
+class UMaterialInstanceDynamic;
+struct FAdaptivePaletteReadback;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnAdaptivePaletteUpdated, const TArray<FLinearColor>&, Palette);
+
+/*
+*	Keeps a palette in sync with the scene.
+*	SourceTarget (expected to be a small scene capture) is copied back with an async GPU readback that is polled
+*	on later ticks, the pixels go to FAdaptivePaletteQuantizer, and every LUT it finishes is written into a
+*	transient DitherColorLUT texture that is set on the target materials (PP_Pixelate instances).
+*/
+UCLASS(ClassGroup = (Rendering), meta = (BlueprintSpawnableComponent))
+class PIXELIZATIONMATERIALS_API UAdaptivePaletteComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UAdaptivePaletteComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	TObjectPtr<UTextureRenderTarget2D> SourceTarget;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	TArray<TObjectPtr<UMaterialInstanceDynamic>> TargetMaterials;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	FName LUTParameterName = TEXT("DitherColorLUT");
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	FAdaptivePaletteSettings Settings;
+
+	UPROPERTY(BlueprintAssignable, Category = "Adaptive Palette")
+	FOnAdaptivePaletteUpdated OnPaletteUpdated;
+
+	UFUNCTION(BlueprintCallable, Category = "Math | Color | Palettes")
+	void ApplySettings();
+
+	UFUNCTION(BlueprintCallable, Category = "Math | Color | Palettes")
+	void ResetPalette();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes")
+	TArray<FLinearColor> GetPalette() const { return Quantizer.GetPalette(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes", meta = (ToolTip = "Palette converted with ConvertPaletteForSearch, ready for findClosestSelectSearchType"))
+	TArray<FVector> GetSearchPalette() const { return Quantizer.GetSearchPalette(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes")
+	UTexture2D* GetLUTTexture() const { return LUTTexture; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes")
+	FAdaptivePaletteStats GetStats() const { return Quantizer.GetStats(); }
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	enum class EReadbackState : uint8 {
+		Idle,
+		Copying,
+		Mapping,
+	};
+
+	void UpdateReadback();
+	void ApplyToMaterials();
+
+	UPROPERTY(Transient)
+	TObjectPtr<UTexture2D> LUTTexture;
+
+	FAdaptivePaletteQuantizer Quantizer;
+	TSharedPtr<FAdaptivePaletteReadback, ESPMode::ThreadSafe> Readback;
+	EReadbackState ReadbackState = EReadbackState::Idle;
+	int32 UploadedLUTVersion = 0;
+};
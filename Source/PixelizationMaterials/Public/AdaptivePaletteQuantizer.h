@@ -0,0 +1,145 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+
+#include "PixelizationMaterialsBPLibrary.h"
+#include "PaletteSearch.h"
+
+#include "AdaptivePaletteQuantizer.generated.h"
+
+USTRUCT(BlueprintType)
+struct PIXELIZATIONMATERIALS_API FAdaptivePaletteSettings {
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette", meta = (ClampMin = "2", ClampMax = "256"))
+	int32 PaletteSize = 16;
+
+	//Frame is box-filtered down to this size before building the histogram
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette", meta = (ClampMin = "1"))
+	FIntPoint SampleSize = FIntPoint(64, 36);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette", meta = (ClampMin = "1"))
+	int32 MaxIterations = 8;
+
+	//k-means and the DitherColorLUT rebuild stop after this many seconds, at least one iteration and one LUT chunk always run
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette", meta = (ClampMin = "0"))
+	float TimeBudgetSeconds = 0.002f;
+
+	//Largest distance (linear RGB) a palette entry may move in one frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette", meta = (ClampMin = "0"))
+	float MaxShiftPerFrame = 0.02f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	TEnumAsByte<EColorSpace> ColorSpace = EColorSpace::RGB;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Adaptive Palette")
+	TEnumAsByte<EColorSearchType> SearchType = EColorSearchType::ClosestOffset;
+};
+
+USTRUCT(BlueprintType)
+struct PIXELIZATIONMATERIALS_API FAdaptivePaletteStats {
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	int32 FrameIndex = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	int32 Iterations = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	int32 HistogramBins = 0;
+
+	//Largest distance any entry moved this frame, after clamping
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	float MaxShift = 0.f;
+
+	//DitherColorLUT cells rebuilt this update, out of DitherLUTCells
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	int32 LUTCells = 0;
+
+	//Wall time of the whole update: readback conversion, downsample, histogram, k-means, search palette and LUT
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Adaptive Palette")
+	float Seconds = 0.f;
+};
+
+/*
+*	Incremental palette quantizer.
+*	Each frame is downsampled, binned into a 15 bit histogram and clustered with k-means that is
+*	warm-started from the previous palette. Entries keep their index between frames and move at most
+*	MaxShiftPerFrame, so palette jitter is bounded.
+*
+*	The DitherColorLUT is rebuilt from a snapshot of the palette in chunks of LUTChunkCells cells, with whatever is
+*	left of TimeBudgetSeconds after k-means. A finished LUT is published and the next rebuild starts from the
+*	current palette, so the LUT trails the palette by a few updates when the budget is small. The search cost per
+*	cell is O(N) for ClosestX/Y/Z and ClosestOffset and O(N^2) for ClosestLine, so the smallest step (one chunk)
+*	costs LUTChunkCells * N^2 segment tests for ClosestLine, about 1M at PaletteSize 256.
+*
+*	Has no UObject or render dependencies: ProcessFrame can be driven directly from synthetic buffers,
+*	SubmitFrame / FetchResult run the same work on a worker task.
+*/
+class PIXELIZATIONMATERIALS_API FAdaptivePaletteQuantizer {
+public:
+	explicit FAdaptivePaletteQuantizer(const FAdaptivePaletteSettings& InSettings = FAdaptivePaletteSettings());
+	~FAdaptivePaletteQuantizer();
+
+	void SetSettings(const FAdaptivePaletteSettings& InSettings);
+	const FAdaptivePaletteSettings& GetSettings() const { return Settings; }
+
+	//Synchronous update on the calling thread
+	void ProcessFrame(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height);
+
+	//Downsamples on the calling thread and starts the quantizer on a worker. Returns false if a frame is still in flight.
+	//ReadbackSeconds is the caller's cost of getting the pixels and is added to the stats
+	bool SubmitFrame(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height, double ReadbackSeconds = 0.);
+
+	//Publishes the worker result. Returns true if a new palette became available
+	bool FetchResult();
+
+	bool IsBusy() const { return PendingTask.IsValid() && !PendingTask.IsCompleted(); }
+	void Wait();
+	void Reset();
+
+	const TArray<FLinearColor>& GetPalette() const { return Palette; }
+	const TArray<FVector>& GetSearchPalette() const { return SearchPalette; }
+	const TArray<FFloat16Color>& GetDitherLUT() const { return DitherLUT; }
+	//Incremented every time a new DitherLUT is published
+	int32 GetDitherLUTVersion() const { return DitherLUTVersion; }
+	const FAdaptivePaletteStats& GetStats() const { return Stats; }
+
+private:
+	void Downsample(TConstArrayView<FLinearColor> Pixels, int32 Width, int32 Height, TArray<FLinearColor>& OutSamples) const;
+	void Quantize(const TArray<FLinearColor>& Samples, double PreparationSeconds);
+	void BuildHistogram(const TArray<FLinearColor>& Samples);
+	void SeedCenters();
+	void UpdateDitherLUT(double StartSeconds);
+	void Publish();
+
+	FAdaptivePaletteSettings Settings;
+
+	//Published state, game thread only
+	TArray<FLinearColor> Palette;
+	TArray<FVector> SearchPalette;
+	TArray<FFloat16Color> DitherLUT;
+	int32 DitherLUTVersion = 0;
+	FAdaptivePaletteStats Stats;
+
+	//Worker state, not touched by the game thread while a task is in flight
+	TArray<FLinearColor> PendingSamples;
+	TArray<FLinearColor> WorkPalette;
+	TArray<FVector> WorkSearchPalette;
+	TArray<FFloat16Color> WorkDitherLUT;
+	TArray<FLinearColor> LUTPalette;
+	FPaletteSearchContext LUTContext;
+	int32 LUTCursor = INDEX_NONE;
+	bool bWorkLUTReady = false;
+	FAdaptivePaletteStats WorkStats;
+	TArray<int32> BinLookup;
+	TArray<FVector3f> BinColors;
+	TArray<float> BinWeights;
+	TArray<int32> BinKeys;
+
+	UE::Tasks::FTask PendingTask;
+};
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+
+#include "PixelizationMaterialsBPLibrary.h"
+
+struct FPaletteSearchResult {
+	int32 IndexA = 0;
+	int32 IndexB = 0;
+	float Blend = 0.f;
+};
+
+/*
+*	Palette prepared for batched findClosestSelectSearchType queries.
+*	Everything that does not depend on the target color (offset directions, line segments, axis min/max,
+*	HSV scaled axis keys) is computed once here, and the kernel for the search type is picked once,
+*	so the per-query loops have no search type or color space branches.
+*/
+struct PIXELIZATIONMATERIALS_API FPaletteSearchContext {
+	FPaletteSearchContext() = default;
+	FPaletteSearchContext(const TArray<FVector>& InPalette, EColorSearchType InSearchType, EColorSpace InColorSpace);
+
+	using FKernel = void (*)(const FPaletteSearchContext& Context, const FVector* Targets, FPaletteSearchResult* Out, int32 Count);
+
+	TArray<FVector> Palette;
+	EColorSearchType SearchType = ClosestOffset;
+	EColorSpace ColorSpace = RGB;
+	FKernel Kernel = nullptr;
+
+	//ClosestOffset: (Palette[j] - Palette[i]).GetUnsafeNormal() and (Palette[j] - Palette[i]).Length() at [i * Num + j]
+	TArray<FVector> OffsetDirections;
+	TArray<double> OffsetLengths;
+
+	//ClosestLine: Palette[j] - Palette[i] and its squared length at [i * Num + j]
+	TArray<FVector> Segments;
+	TArray<double> SegmentLengthsSquared;
+
+	//ClosestX/Y/Z: component values, values compared against the target (v / max for HSV Y and Z) and the first pass extremes
+	TArray<float> AxisValues;
+	TArray<float> AxisKeys;
+	float AxisMin = UE_MAX_FLT;
+	float AxisMax = -UE_MAX_FLT;
+	int32 AxisMinIndex = 0;
+	int32 AxisMaxIndex = 0;
+};
+
+//Bit-identical to calling findClosestSelectSearchType per target with colorA and colorB initialized to Palette[0].
+//Out must hold at least Targets.Num() results, colorA / colorB are Context.Palette[IndexA] / Context.Palette[IndexB]
+PIXELIZATIONMATERIALS_API void FindClosestBatch(const FPaletteSearchContext& Context, TConstArrayView<FVector3f> Targets, TArrayView<FPaletteSearchResult> Out);
+PIXELIZATIONMATERIALS_API void FindClosestBatch(const FPaletteSearchContext& Context, TConstArrayView<FVector> Targets, TArrayView<FPaletteSearchResult> Out);
+
+//Black has no CIELUV chromaticity (0 / 0), so some targets cannot be searched. Their results are replaced with the darkest
+//entry of Palette (IndexA = IndexB, Blend 0), Palette being the colors the search palette was converted from
+PIXELIZATIONMATERIALS_API void ResolveNonFiniteTargets(const TArray<FLinearColor>& Palette, TConstArrayView<FVector> Targets, TArrayView<FPaletteSearchResult> Results);
+
+//DitherColorLUT layout read by MF_DitherColorSelection: a 16^3 RGB cube unwrapped to 256x16 (red along x inside a slice,
+//blue slices along x, green along y), stacked three times for colorA, colorB and blend
+const int32 DitherLUTResolution = 16;
+const int32 DitherLUTWidth = DitherLUTResolution * DitherLUTResolution;
+const int32 DitherLUTHeight = DitherLUTResolution * 3;
+const int32 DitherLUTCells = DitherLUTResolution * DitherLUTResolution * DitherLUTResolution;
+
+//Fills OutLUT (DitherLUTWidth x DitherLUTHeight) for Palette, Context must be built from the same palette converted for search
+PIXELIZATIONMATERIALS_API void BuildDitherLUT(const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, TArray<FFloat16Color>& OutLUT);
+
+//Fills only cells [FirstCell, FirstCell + NumCells) of the cube, OutLUT must already hold DitherLUTWidth x DitherLUTHeight texels.
+//Lets a LUT rebuild be spread over several calls
+PIXELIZATIONMATERIALS_API void BuildDitherLUTCells(const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, int32 FirstCell, int32 NumCells, TArray<FFloat16Color>& OutLUT);
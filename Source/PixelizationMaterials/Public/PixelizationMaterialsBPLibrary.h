@@ -11,6 +11,8 @@
 
 #include "PixelizationMaterialsBPLibrary.generated.h"
 
+struct FPaletteSearchContext;
+
 
 /* 
 *	Function library class.
@@ -56,7 +58,7 @@ enum EColorSearchType {
 };
 
 UCLASS()
-class UPixelizationMaterialsBPLibrary : public UBlueprintFunctionLibrary
+class PIXELIZATIONMATERIALS_API UPixelizationMaterialsBPLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_UCLASS_BODY()
 
@@ -74,6 +76,8 @@ class UPixelizationMaterialsBPLibrary : public UBlueprintFunctionLibrary
 	UFUNCTION(BlueprintCallable, Category = "Math | Color ")
 	static bool ReadPalleteFromFile(TArray<FLinearColor>& Pallete, FString& PalleteName);
 
+	static bool ReadPalleteFromPath(const FString& FilePath, TArray<FLinearColor>& Pallete, FString& PalleteName);
+
 	//----ColorSpaceConvertions
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color ", meta = (DisplayName = "HSV to position", ToolTip = "converts HSV color to position in imaginary 3D cylinder"))
@@ -129,7 +133,18 @@ class UPixelizationMaterialsBPLibrary : public UBlueprintFunctionLibrary
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes", meta = ( ToolTip = ""))
 	static void findClosestSelectSearchType(TArray<FVector> palette, FVector targetColor, EColorSearchType searchType, EColorSpace ColorSpace, FVector& colorA, FVector& colorB, float& blend);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Math | Color | Palettes", meta = (DisplayName = "Color selection: Find closest for array", ToolTip = "findClosestSelectSearchType for every target color, the palette is prepared once"))
+	static void findClosestBatchSelectSearchType(const TArray<FVector>& palette, const TArray<FVector>& targetColors, EColorSearchType searchType, EColorSpace ColorSpace, TArray<FVector>& colorsA, TArray<FVector>& colorsB, TArray<float>& blends);
 	//----
 
+	//Replaces every pixel with a palette color, picking between colorA and colorB of the selected search.
+	//PixelSize > 1 averages PixelSize x PixelSize blocks first (weighted by alpha), bDither uses a 4x4 Bayer threshold instead of 0.5
+	static void PalettizePixels(TArray<FColor>& Pixels, int32 Width, int32 Height, const TArray<FLinearColor>& Palette, EColorSpace ColorSpace, EColorSearchType SearchType, int32 PixelSize = 1, bool bDither = false);
+
+	//Same as above with a prebuilt search context, so one context can be shared between many images.
+	//Context must be built from Palette converted with ConvertPaletteForSearch for its color space and search type
+	static void PalettizePixels(TArray<FColor>& Pixels, int32 Width, int32 Height, const TArray<FLinearColor>& Palette, const FPaletteSearchContext& Context, int32 PixelSize = 1, bool bDither = false);
+
 };
 
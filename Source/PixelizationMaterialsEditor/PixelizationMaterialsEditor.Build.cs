@@ -0,0 +1,30 @@
+// Some copyright should be here...
+
+using UnrealBuildTool;
+
+public class PixelizationMaterialsEditor : ModuleRules
+{
+	public PixelizationMaterialsEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+			}
+			);
+
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"CoreUObject",
+				"Engine",
+				"AssetRegistry",
+				"ImageCore",
+				"PixelizationMaterials",
+			}
+			);
+	}
+}
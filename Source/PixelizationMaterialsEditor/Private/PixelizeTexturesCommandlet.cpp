@@ -0,0 +1,301 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "PixelizeTexturesCommandlet.h"
+
+#include "PixelizationMaterialsBPLibrary.h"
+#include "PaletteSearch.h"
+
+#include "Async/ParallelFor.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Texture2D.h"
+#include "ImageCore.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPixelizeTextures, Log, All);
+
+namespace {
+    //Textures are loaded, palettized and saved in batches so memory stays bounded on large content paths
+    const int32 BatchSize = 64;
+
+    struct FPixelizeOutputSettings {
+        bool bKeepMips = false;
+        bool bKeepCompression = false;
+    };
+
+    struct FManifestEntry {
+        FString InputId;
+        FString SettingsHash;
+        FString OutputId;
+    };
+
+    struct FPixelizeJob {
+        UTexture2D* Texture = nullptr;
+        FString InputId;
+        FString OutputPackage;
+        TArray<FColor> Pixels;
+        int32 Width = 0;
+        int32 Height = 0;
+    };
+
+    void LoadManifest(const FString& FilePath, TMap<FString, FManifestEntry>& Manifest) {
+        TArray<FString> lines;
+        if (!FFileHelper::LoadFileToStringArray(lines, *FilePath)) return;
+
+        for (const FString& line : lines) {
+            TArray<FString> fields;
+            line.ParseIntoArray(fields, TEXT(";"), false);
+            if (fields.Num() != 4) continue;
+            Manifest.Add(fields[0], { fields[1], fields[2], fields[3] });
+        }
+    }
+
+    void SaveManifest(const FString& FilePath, const TMap<FString, FManifestEntry>& Manifest) {
+        TArray<FString> lines;
+        for (const TPair<FString, FManifestEntry>& entry : Manifest) {
+            lines.Add(FString::Printf(TEXT("%s;%s;%s;%s"), *entry.Key, *entry.Value.InputId, *entry.Value.SettingsHash, *entry.Value.OutputId));
+        }
+        lines.Sort();
+        FFileHelper::SaveStringArrayToFile(lines, *FilePath);
+    }
+
+    FString HashSettings(const TArray<FLinearColor>& Palette, const FString& Settings) {
+        FMD5 md5;
+        md5.Update(reinterpret_cast<const uint8*>(Palette.GetData()), Palette.Num() * sizeof(FLinearColor));
+        md5.Update(reinterpret_cast<const uint8*>(*Settings), Settings.Len() * sizeof(TCHAR));
+
+        FMD5Hash hash;
+        hash.Set(md5);
+        return LexToString(hash);
+    }
+
+    //Hash of the package file as last saved, available from the asset registry without loading the texture
+    FString GetPackageSavedHash(const IAssetRegistry& AssetRegistry, const FString& PackageName) {
+        TOptional<FAssetPackageData> packageData = AssetRegistry.GetAssetPackageDataCopy(FName(*PackageName));
+        return packageData.IsSet() ? LexToString(packageData->GetPackageSavedHash()) : FString();
+    }
+
+    bool ReadSourcePixels(UTexture2D* Texture, TArray<FColor>& OutPixels, int32& OutWidth, int32& OutHeight) {
+        if (!Texture->Source.IsValid()) return false;
+
+        FImage source;
+        if (!Texture->Source.GetMipImage(source, 0, 0, 0)) return false;
+
+        //GetMipImage tags the image with the texture's gamma, so linear sources are encoded to sRGB here
+        FImage bgra;
+        source.CopyTo(bgra, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+
+        OutWidth = bgra.SizeX;
+        OutHeight = bgra.SizeY;
+        TArrayView64<FColor> view = bgra.AsBGRA8();
+        OutPixels = TArray<FColor>(view.GetData(), OutWidth * OutHeight);
+        return true;
+    }
+
+    UTexture2D* FindOrCreateOutput(UTexture2D* Source, const FString& OutputPackage) {
+        FString assetName = FPackageName::GetLongPackageAssetName(OutputPackage);
+
+        if (FPackageName::DoesPackageExist(OutputPackage)) {
+            UTexture2D* existing = LoadObject<UTexture2D>(nullptr, *(OutputPackage + TEXT(".") + assetName));
+            if (existing) return existing;
+        }
+
+        UPackage* package = CreatePackage(*OutputPackage);
+        UTexture2D* output = DuplicateObject<UTexture2D>(Source, package, FName(*assetName));
+        output->SetFlags(RF_Public | RF_Standalone);
+        FAssetRegistryModule::AssetCreated(output);
+        return output;
+    }
+
+    //Palette colors only survive exactly without mips and block compression.
+    //PalettizePixels writes sRGB encoded palette colors, outputs of linear sources must not keep SRGB = false
+    void ApplyOutputSettings(UTexture2D* Texture, const FPixelizeOutputSettings& Settings) {
+        Texture->Filter = TF_Nearest;
+        Texture->SRGB = true;
+        if (!Settings.bKeepMips) Texture->MipGenSettings = TMGS_NoMipmaps;
+        if (!Settings.bKeepCompression) Texture->CompressionSettings = TC_EditorIcon;
+    }
+
+    //Rescans the saved file so the registry reports the new package hash
+    bool SaveTexturePackage(UTexture2D* Texture, IAssetRegistry& AssetRegistry) {
+        UPackage* package = Texture->GetOutermost();
+        package->MarkPackageDirty();
+        FString filename = FPackageName::LongPackageNameToFilename(package->GetName(), FPackageName::GetAssetPackageExtension());
+
+        FSavePackageArgs args;
+        args.TopLevelFlags = RF_Public | RF_Standalone;
+        args.SaveFlags = SAVE_NoError;
+        if (!UPackage::SavePackage(package, Texture, *filename, args)) return false;
+
+        AssetRegistry.ScanFilesSynchronous({ filename }, true);
+        return true;
+    }
+}
+
+UPixelizeTexturesCommandlet::UPixelizeTexturesCommandlet() {
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+
+    HelpDescription = TEXT("Palettizes every UTexture2D under a content path, skipping textures unchanged since the last run");
+    HelpUsage = TEXT("-run=PixelizeTextures -Path=/Game/Sprites -Palette=<file> [-ColorSpace=RGB] [-SearchType=ClosestOffset] [-PixelSize=1] [-Dither] [-InPlace] [-Suffix=_Pixelized] [-KeepMips] [-KeepCompression] [-Manifest=<file>] [-Force]");
+}
+
+int32 UPixelizeTexturesCommandlet::Main(const FString& Params) {
+    FString contentPath;
+    FString palettePath;
+    if (!FParse::Value(*Params, TEXT("Path="), contentPath) || !FParse::Value(*Params, TEXT("Palette="), palettePath)) {
+        UE_LOG(LogPixelizeTextures, Error, TEXT("Usage: %s"), *HelpUsage);
+        return 1;
+    }
+
+    FString colorSpaceName = TEXT("RGB");
+    FString searchTypeName = TEXT("ClosestOffset");
+    FString suffix = TEXT("_Pixelized");
+    FString manifestPath = FPaths::ProjectSavedDir() / TEXT("PixelizeTextures/Manifest.txt");
+    int32 pixelSize = 1;
+    FParse::Value(*Params, TEXT("ColorSpace="), colorSpaceName);
+    FParse::Value(*Params, TEXT("SearchType="), searchTypeName);
+    FParse::Value(*Params, TEXT("Suffix="), suffix);
+    FParse::Value(*Params, TEXT("Manifest="), manifestPath);
+    FParse::Value(*Params, TEXT("PixelSize="), pixelSize);
+    pixelSize = FMath::Max(pixelSize, 1);
+    const bool bDither = FParse::Param(*Params, TEXT("Dither"));
+    const bool bInPlace = FParse::Param(*Params, TEXT("InPlace"));
+    const bool bForce = FParse::Param(*Params, TEXT("Force"));
+
+    if (!bInPlace && suffix.IsEmpty()) {
+        UE_LOG(LogPixelizeTextures, Error, TEXT("An empty -Suffix= needs -InPlace, outputs would overwrite their sources"));
+        return 1;
+    }
+
+    FPixelizeOutputSettings outputSettings;
+    outputSettings.bKeepMips = FParse::Param(*Params, TEXT("KeepMips"));
+    outputSettings.bKeepCompression = FParse::Param(*Params, TEXT("KeepCompression"));
+
+    int64 colorSpaceValue = StaticEnum<EColorSpace>()->GetValueByNameString(colorSpaceName);
+    int64 searchTypeValue = StaticEnum<EColorSearchType>()->GetValueByNameString(searchTypeName);
+    if (colorSpaceValue == INDEX_NONE || searchTypeValue == INDEX_NONE) {
+        UE_LOG(LogPixelizeTextures, Error, TEXT("Unknown ColorSpace '%s' or SearchType '%s'"), *colorSpaceName, *searchTypeName);
+        return 1;
+    }
+    const EColorSpace colorSpace = (EColorSpace)colorSpaceValue;
+    const EColorSearchType searchType = (EColorSearchType)searchTypeValue;
+
+    TArray<FLinearColor> palette;
+    FString paletteName;
+    if (!UPixelizationMaterialsBPLibrary::ReadPalleteFromPath(palettePath, palette, paletteName) || palette.IsEmpty()) {
+        UE_LOG(LogPixelizeTextures, Error, TEXT("Could not read palette from %s"), *palettePath);
+        return 1;
+    }
+
+    //Resolved enum values, names are matched case-insensitively. Outputs are always written as sRGB,
+    //part of the hash so outputs written before that are redone
+    const FString settingsHash = HashSettings(palette, FString::Printf(TEXT("%d;%d;%d;%d;%d;%s;%d;%d;sRGB"),
+        (int32)colorSpace, (int32)searchType, pixelSize, bDither, bInPlace, *suffix, outputSettings.bKeepMips, outputSettings.bKeepCompression));
+
+    //Shared read-only by every job, building it is O(N^2) in the palette size for ClosestLine and ClosestOffset
+    const FPaletteSearchContext searchContext(UPixelizationMaterialsBPLibrary::ConvertPaletteForSearch(palette, colorSpace, searchType), searchType, colorSpace);
+
+    TMap<FString, FManifestEntry> manifest;
+    LoadManifest(manifestPath, manifest);
+
+    IAssetRegistry& assetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+    assetRegistry.SearchAllAssets(true);
+
+    FARFilter filter;
+    filter.PackagePaths.Add(FName(*contentPath));
+    filter.bRecursivePaths = true;
+    filter.ClassPaths.Add(UTexture2D::StaticClass()->GetClassPathName());
+
+    TArray<FAssetData> assets;
+    assetRegistry.GetAssets(filter, assets);
+    UE_LOG(LogPixelizeTextures, Display, TEXT("Found %d textures under %s, palette %s (%d colors)"), assets.Num(), *contentPath, *paletteName, palette.Num());
+
+    int32 processed = 0;
+    int32 skipped = 0;
+    int32 failed = 0;
+
+    //Manifest check only needs registry data, so unchanged textures are never loaded
+    TArray<const FAssetData*> pending;
+    for (const FAssetData& asset : assets) {
+        FString packageName = asset.PackageName.ToString();
+        if (!bInPlace && packageName.EndsWith(suffix)) continue;
+
+        //Keyed by output, so runs with different palettes / suffixes sharing a manifest keep their own entries
+        FString outputPackage = bInPlace ? packageName : packageName + suffix;
+        const FManifestEntry* entry = bForce ? nullptr : manifest.Find(outputPackage);
+        if (entry) {
+            FString inputId = GetPackageSavedHash(assetRegistry, packageName);
+            bool bSourceUnchanged = !inputId.IsEmpty() && (entry->InputId == inputId || (bInPlace && entry->OutputId == inputId));
+            bool bOutputExists = bInPlace || FPackageName::DoesPackageExist(outputPackage);
+            if (entry->SettingsHash == settingsHash && bSourceUnchanged && bOutputExists) {
+                skipped++;
+                continue;
+            }
+        }
+        pending.Add(&asset);
+    }
+
+    for (int32 batchStart = 0; batchStart < pending.Num(); batchStart += BatchSize) {
+        TArray<FPixelizeJob> jobs;
+
+        //Loading and source access stay on the game thread
+        for (int32 i = batchStart; i < FMath::Min(batchStart + BatchSize, pending.Num()); i++) {
+            const FAssetData& asset = *pending[i];
+            FString packageName = asset.PackageName.ToString();
+
+            //Read before loading, the hash of the package as it is on disk
+            FString inputId = GetPackageSavedHash(assetRegistry, packageName);
+
+            UTexture2D* texture = Cast<UTexture2D>(asset.GetAsset());
+            if (!texture || !texture->Source.IsValid()) {
+                failed++;
+                continue;
+            }
+
+            FPixelizeJob& job = jobs.AddDefaulted_GetRef();
+            job.Texture = texture;
+            job.InputId = inputId;
+            job.OutputPackage = bInPlace ? packageName : packageName + suffix;
+            if (!ReadSourcePixels(texture, job.Pixels, job.Width, job.Height)) {
+                jobs.Pop();
+                failed++;
+            }
+        }
+
+        ParallelFor(jobs.Num(), [&](int32 i) {
+            FPixelizeJob& job = jobs[i];
+            UPixelizationMaterialsBPLibrary::PalettizePixels(job.Pixels, job.Width, job.Height, palette, searchContext, pixelSize, bDither);
+        });
+
+        for (FPixelizeJob& job : jobs) {
+            UTexture2D* output = bInPlace ? job.Texture : FindOrCreateOutput(job.Texture, job.OutputPackage);
+            output->Modify();
+            output->Source.Init(job.Width, job.Height, 1, 1, TSF_BGRA8, reinterpret_cast<const uint8*>(job.Pixels.GetData()));
+            ApplyOutputSettings(output, outputSettings);
+            output->PostEditChange();
+
+            if (!SaveTexturePackage(output, assetRegistry)) {
+                UE_LOG(LogPixelizeTextures, Warning, TEXT("Failed to save %s"), *job.OutputPackage);
+                failed++;
+                continue;
+            }
+
+            manifest.Add(job.OutputPackage, { job.InputId, settingsHash, GetPackageSavedHash(assetRegistry, job.OutputPackage) });
+            processed++;
+        }
+
+        //Saved per batch, an interrupted -InPlace run would otherwise redo (and re-palettize) finished textures
+        SaveManifest(manifestPath, manifest);
+        CollectGarbage(RF_NoFlags);
+    }
+
+    UE_LOG(LogPixelizeTextures, Display, TEXT("Processed %d, skipped %d, failed %d"), processed, skipped, failed);
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "PixelizeTexturesCommandlet.generated.h"
+
+/*
+*	Palettizes every UTexture2D under a content path.
+*
+*	UnrealEditor-Cmd.exe Project.uproject -run=PixelizeTextures -Path=/Game/Sprites -Palette=D:/Palettes/Apollo.gpl
+*		-ColorSpace=CIELUV		EColorSpace used for the search, RGB by default
+*		-SearchType=ClosestX	EColorSearchType, ClosestOffset by default
+*		-PixelSize=2			averages NxN blocks before palettizing
+*		-Dither					4x4 ordered dither between colorA and colorB
+*		-InPlace				overwrite the source textures instead of writing <Name><Suffix> next to them
+*		-Suffix=_Pixelized
+*		-KeepMips				keep the source mip settings, outputs have no mips by default
+*		-KeepCompression		keep the source compression, outputs are uncompressed BGRA8 by default
+*
+*	Outputs are always sRGB: linear sources are encoded to sRGB before palettizing and the output SRGB flag is set.
+*		-Manifest=<file>		defaults to Saved/PixelizeTextures/Manifest.txt
+*		-Force					ignore the manifest
+*
+*	The manifest stores the saved package hash of the source, palette + settings hash and the saved package hash
+*	of the output per output package, so runs with different palettes and suffixes can share one manifest. Hashes come from the asset registry, textures whose entry still matches are skipped
+*	without being loaded.
+*/
+UCLASS()
+class UPixelizeTexturesCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPixelizeTexturesCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};